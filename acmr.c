@@ -0,0 +1,37 @@
+// standard includes
+#include <stdio.h>
+
+// application specific includes
+#include "terrain.h"
+#include "perlin.h"
+#include "vcache.h"
+
+// globals required by the terrain generation, unused when only the indices are generated
+vec3s position;
+int seed;
+
+// terrain data
+static unsigned int terrain_draw_indices[TERRAIN_NUM_DRAW_INDICES];
+
+// print the average cache miss ratio of the terrain draw order for different tile and cache sizes
+int main(void)
+{
+    const size_t tile_sizes[]  = {TERRAIN_ROW_ORDER_TILE_SIZE, 4, 8, 16, 32};
+    const size_t cache_sizes[] = {8, 16, 24, 32, 64};
+    const size_t num_tile_sizes  = sizeof(tile_sizes) / sizeof(tile_sizes[0]);
+    const size_t num_cache_sizes = sizeof(cache_sizes) / sizeof(cache_sizes[0]);
+
+    printf("%10s %10s %10s %10s\n", "tile size", "cache size", "FIFO ACMR", "LRU ACMR");
+
+    for (size_t i = 0; i < num_tile_sizes; ++i) {
+        fill_terrain_draw_indices(tile_sizes[i], terrain_draw_indices);
+
+        for (size_t j = 0; j < num_cache_sizes; ++j) {
+            printf("%10zu %10zu %10.3f %10.3f\n", tile_sizes[i], cache_sizes[j],
+                   compute_acmr(terrain_draw_indices, TERRAIN_NUM_DRAW_INDICES, cache_sizes[j], VERTEX_CACHE_FIFO),
+                   compute_acmr(terrain_draw_indices, TERRAIN_NUM_DRAW_INDICES, cache_sizes[j], VERTEX_CACHE_LRU));
+        }
+    }
+
+    return 0;
+}
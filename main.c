@@ -7,21 +7,20 @@
 
 // application specific includes
 #include "terrain.h"
+#include "pyramid.h"
+#include "player.h"
 #include "shader.h"
 #include "light.h"
 
 // globals
-#define CAMERA_HEIGHT      15  // how much higher the camera is compared to the maximum height of the mountains
-#define UPDATE_THRESHOLD   5   // distance between terrain updates
-#define MOVEMENT_SPEED     2   // how quickly the player can move
 static float angle_rad_y = 0.0;  // angle to rotate scene
 vec3s position = {0.0, -TERRAIN_MAX_HEIGHT - CAMERA_HEIGHT, 0.0};  // player current position
 
 // terrain data
 static Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE];
 static unsigned int terrain_indices[TERRAIN_NUM_VERTICES_SIDE - 1][TERRAIN_NUM_INDICES_X];
-static int terrain_counts[TERRAIN_NUM_VERTICES_SIDE - 1];
-static void* terrain_offsets[TERRAIN_NUM_VERTICES_SIDE - 1];
+static unsigned int terrain_draw_indices[TERRAIN_NUM_DRAW_INDICES];
+static HeightPyramid height_pyramid;  // min/max heights of the terrain, for ray and visibility queries
 
 static mat4 model_view_matrix = GLM_MAT4_IDENTITY_INIT;
 static mat4 projection_matrix = GLM_MAT4_IDENTITY_INIT;
@@ -61,25 +60,19 @@ void display(void)
     glUniformMatrix3fv(normal_matrix_location, 1, GL_FALSE, (GLfloat *)normal_matrix);
 
     /* Draw terrain */
-    glMultiDrawElements(GL_TRIANGLE_STRIP, terrain_counts, GL_UNSIGNED_INT, (const void **)terrain_offsets, TERRAIN_NUM_VERTICES_SIDE - 1);
+    glDrawElements(GL_TRIANGLES, TERRAIN_NUM_DRAW_INDICES, GL_UNSIGNED_INT, 0);
 
     /* Update terrain */
     static enum update_steps { POSITION, VERTICES, NORMALS, VBO } step;
     static vec3s position_last_update;  // player position at the time of the last terrain update
-    const bool should_update_x = abs((int)(position.x - position_last_update.x)) >= UPDATE_THRESHOLD;
-    const bool should_update_z = abs((int)(position.z - position_last_update.z)) >= UPDATE_THRESHOLD;
 
-    if (step || should_update_x || should_update_z) {
+    if (step || should_update_terrain(position_last_update)) {
         static ivec3s num_chunks;  // number of chunks to update
 
         switch (step) {
             case POSITION: {
                 // determine number of chunks to generate on the x and z axis
-                num_chunks = (ivec3s) { .x = round(((position.x - position_last_update.x) / TERRAIN_CHUNK_SIZE)),
-                                        .z = round(((position_last_update.z - position.z) / TERRAIN_CHUNK_SIZE)) };
-
-                // update variable to track user position at the time of the last update
-                glm_vec3_copy(position.raw, position_last_update.raw);
+                num_chunks = get_num_chunks(&position_last_update);
 
                 ++step;
                 break;
@@ -87,6 +80,7 @@ void display(void)
             case VERTICES: {
                 // update the new terrain at the current location
                 update_terrain_vertices(num_chunks, terrain_vertices);
+                update_height_pyramid(&height_pyramid, num_chunks, terrain_vertices);
 
                 ++step;
                 break;
@@ -151,7 +145,8 @@ void init(void)
     glUseProgram(program_id);
 
     // initialize terrain
-    init_terrain(terrain_vertices, terrain_indices, terrain_counts, terrain_offsets);
+    init_terrain(terrain_vertices, terrain_indices, terrain_draw_indices);
+    init_height_pyramid(&height_pyramid, terrain_vertices);
 
     // create VAO and VBOs
     GLuint buffer[2], vao;
@@ -163,7 +158,7 @@ void init(void)
     glBindBuffer(GL_ARRAY_BUFFER, buffer[TERRAIN_VERTICES]);
     glBufferData(GL_ARRAY_BUFFER, sizeof(terrain_vertices), terrain_vertices, GL_DYNAMIC_DRAW);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer[TERRAIN_INDICES]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(terrain_indices), terrain_indices, GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(terrain_draw_indices), terrain_draw_indices, GL_STATIC_DRAW);
     // add coordinates
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(terrain_vertices[0]), 0);
     glEnableVertexAttribArray(0);
@@ -203,34 +198,12 @@ void keyInput(unsigned char key, int x, int y)
     switch(key) {
         case 27:
             exit(0);
-        case 'W':  // move forward
-        case 'w': {
-            position.z += MOVEMENT_SPEED * sin(angle_rad_y + GLM_PI_2);
-            position.x += MOVEMENT_SPEED * cos(angle_rad_y + GLM_PI_2);
-            glutPostRedisplay();
-            break;
-        }
-        case 'S':  // move backward
-        case 's': {
-            position.z -= MOVEMENT_SPEED * sin(angle_rad_y + GLM_PI_2);
-            position.x -= MOVEMENT_SPEED * cos(angle_rad_y + GLM_PI_2);
-            glutPostRedisplay();
-            break;
-        }
-        case 'A':  // rotate left
-        case 'a': {
-            angle_rad_y -= glm_rad(1);
-            glutPostRedisplay();
-            break;
-        }
-        case 'D':  // rotate right
-        case 'd': {
-            angle_rad_y += glm_rad(1);
-            glutPostRedisplay();
-            break;
-        }
         default: {
-             break;
+            // move or rotate the player
+            if (move_player(key, &angle_rad_y)) {
+                glutPostRedisplay();
+            }
+            break;
         }
     }
 }
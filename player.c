@@ -0,0 +1,58 @@
+#include <cglm/cglm.h>
+#include <stdlib.h>
+
+#include "player.h"
+
+// move or rotate the player for a key, returns whether the key was a movement one
+bool move_player(const unsigned char key, float* angle_rad_y)
+{
+    switch (key) {
+        case 'W':  // move forward
+        case 'w': {
+            position.z += MOVEMENT_SPEED * sin(*angle_rad_y + GLM_PI_2);
+            position.x += MOVEMENT_SPEED * cos(*angle_rad_y + GLM_PI_2);
+            return true;
+        }
+        case 'S':  // move backward
+        case 's': {
+            position.z -= MOVEMENT_SPEED * sin(*angle_rad_y + GLM_PI_2);
+            position.x -= MOVEMENT_SPEED * cos(*angle_rad_y + GLM_PI_2);
+            return true;
+        }
+        case 'A':  // rotate left
+        case 'a': {
+            *angle_rad_y -= glm_rad(1);
+            return true;
+        }
+        case 'D':  // rotate right
+        case 'd': {
+            *angle_rad_y += glm_rad(1);
+            return true;
+        }
+        default: {
+            return false;
+        }
+    }
+}
+
+// check if the player moved far enough from the last terrain update
+bool should_update_terrain(const vec3s position_last_update)
+{
+    const bool should_update_x = abs((int)(position.x - position_last_update.x)) >= UPDATE_THRESHOLD;
+    const bool should_update_z = abs((int)(position.z - position_last_update.z)) >= UPDATE_THRESHOLD;
+
+    return should_update_x || should_update_z;
+}
+
+// get the number of chunks to generate on the x and z axis, and track the player position of this update
+ivec3s get_num_chunks(vec3s* position_last_update)
+{
+    const ivec3s num_chunks = { .x = round(((position.x - position_last_update->x) / TERRAIN_CHUNK_SIZE)),
+                                .z = round(((position_last_update->z - position.z) / TERRAIN_CHUNK_SIZE)) };
+
+    // advance by the whole chunks the terrain moves, so the rounding left over is kept for the next update
+    position_last_update->x += num_chunks.x * TERRAIN_CHUNK_SIZE;
+    position_last_update->z -= num_chunks.z * TERRAIN_CHUNK_SIZE;
+
+    return num_chunks;
+}
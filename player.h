@@ -0,0 +1,18 @@
+#ifndef PROCEDURAL_TERRAIN_GENERATION_PLAYER_H
+#define PROCEDURAL_TERRAIN_GENERATION_PLAYER_H
+
+#include <stdbool.h>
+
+#include "terrain.h"
+
+#define CAMERA_HEIGHT      15  // how much higher the camera is compared to the maximum height of the mountains
+#define UPDATE_THRESHOLD   5   // distance between terrain updates
+#define MOVEMENT_SPEED     2   // how quickly the player can move
+
+bool move_player(const unsigned char key, float* angle_rad_y);
+
+bool should_update_terrain(const vec3s position_last_update);
+
+ivec3s get_num_chunks(vec3s* position_last_update);
+
+#endif //PROCEDURAL_TERRAIN_GENERATION_PLAYER_H
@@ -0,0 +1,392 @@
+#include <cglm/cglm.h>
+#include <float.h>
+#include <stdlib.h>
+
+#include "pyramid.h"
+
+#define VISIBILITY_EPSILON 1e-4f  // fraction of a segment ignored at each end, so that points on the ground can see each other
+
+// ray used during the traversal, also expressed in terrain squares from the first resident vertex
+typedef struct {
+    vec3s origin;
+    vec3s direction;
+    float direction_length;   // scales the tolerances, so that they do not depend on the length of the direction
+    float grid_origin[2];     // origin on x and z, in squares
+    float grid_direction[2];  // direction on x and z, in squares
+    float min_distance;
+    float max_distance;
+} GridRay;
+
+// position of the first block of each level in the ranges array
+static const size_t level_offsets[PYRAMID_MAX_LEVELS] = {
+    PYRAMID_LEVEL_OFFSET(0), PYRAMID_LEVEL_OFFSET(1), PYRAMID_LEVEL_OFFSET(2),  PYRAMID_LEVEL_OFFSET(3),
+    PYRAMID_LEVEL_OFFSET(4), PYRAMID_LEVEL_OFFSET(5), PYRAMID_LEVEL_OFFSET(6),  PYRAMID_LEVEL_OFFSET(7),
+    PYRAMID_LEVEL_OFFSET(8), PYRAMID_LEVEL_OFFSET(9), PYRAMID_LEVEL_OFFSET(10), PYRAMID_LEVEL_OFFSET(11)
+};
+
+// divide by 2 to the power of level, rounding towards negative infinity
+static inline int floor_shift(const int value, const int level)
+{
+    return (value >= 0) ? (value >> level) : -((-value - 1) >> level) - 1;
+}
+
+// get the position of a block in the ranges array, given its world grid coordinates
+static size_t range_index(const int level, const int block_x, const int block_z)
+{
+    const int side = PYRAMID_LEVEL_SIDE(level);
+
+    // wrap around the level, so that blocks keep their position when the terrain moves
+    const int wrapped_x = ((block_x % side) + side) % side;
+    const int wrapped_z = ((block_z % side) + side) % side;
+
+    return level_offsets[level] + (wrapped_z * side) + wrapped_x;
+}
+
+// recompute the ranges of the blocks covering the given squares, in squares from the first resident one
+static void refresh_blocks(HeightPyramid* pyramid, const int level, const ivec3s matrix_start, const ivec3s matrix_end,
+                           const Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE])
+{
+    const ivec3s origin = pyramid->origin;
+
+    // convert to world grid coordinates, keeping only the resident squares
+    const ivec3s start = { .x = glm_imax(matrix_start.x, 0) + origin.x, .z = glm_imax(matrix_start.z, 0) + origin.z };
+    const ivec3s end   = { .x = glm_imin(matrix_end.x, PYRAMID_NUM_CELLS_SIDE) + origin.x,
+                           .z = glm_imin(matrix_end.z, PYRAMID_NUM_CELLS_SIDE) + origin.z };
+    if (start.x >= end.x || start.z >= end.z) {
+        return;
+    }
+
+    // determine the resident blocks of the level below, unused for the squares of the first level
+    const int child_level = glm_imax(level - 1, 0);
+    const ivec3s first_child = { .x = floor_shift(origin.x, child_level), .z = floor_shift(origin.z, child_level) };
+    const ivec3s last_child  = { .x = floor_shift(origin.x + PYRAMID_NUM_CELLS_SIDE - 1, child_level),
+                                 .z = floor_shift(origin.z + PYRAMID_NUM_CELLS_SIDE - 1, child_level) };
+
+    for (int block_z = floor_shift(start.z, level); block_z <= floor_shift(end.z - 1, level); ++block_z) {
+        for (int block_x = floor_shift(start.x, level); block_x <= floor_shift(end.x - 1, level); ++block_x) {
+            HeightRange range = { .min = FLT_MAX, .max = -FLT_MAX };
+
+            if (level == 0) {
+                // get the range of the four vertices of the square
+                const size_t top_left = ((block_z - origin.z) * TERRAIN_NUM_VERTICES_SIDE) + (block_x - origin.x);
+                const size_t corners[4] = { top_left, top_left + 1,
+                                            top_left + TERRAIN_NUM_VERTICES_SIDE, top_left + TERRAIN_NUM_VERTICES_SIDE + 1 };
+
+                for (size_t i = 0; i < 4; ++i) {
+                    range.min = glm_min(range.min, terrain_vertices[corners[i]].coords[1]);
+                    range.max = glm_max(range.max, terrain_vertices[corners[i]].coords[1]);
+                }
+            } else {
+                // merge the ranges of the resident blocks below
+                for (int child_z = block_z * 2; child_z <= (block_z * 2) + 1; ++child_z) {
+                    for (int child_x = block_x * 2; child_x <= (block_x * 2) + 1; ++child_x) {
+                        if (child_x < first_child.x || child_x > last_child.x ||
+                            child_z < first_child.z || child_z > last_child.z) {
+                            continue;
+                        }
+
+                        const HeightRange child = pyramid->ranges[range_index(level - 1, child_x, child_z)];
+                        range.min = glm_min(range.min, child.min);
+                        range.max = glm_max(range.max, child.max);
+                    }
+                }
+            }
+
+            pyramid->ranges[range_index(level, block_x, block_z)] = range;
+        }
+    }
+}
+
+// build the pyramid of the whole terrain
+void init_height_pyramid(HeightPyramid* pyramid, const Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE])
+{
+    pyramid->origin = (ivec3s) { .x = 0, .z = 0 };
+
+    for (int level = 0; level < PYRAMID_NUM_LEVELS; ++level) {
+        refresh_blocks(pyramid, level,
+                       (ivec3s) { .x = 0, .z = 0 },
+                       (ivec3s) { .x = PYRAMID_NUM_CELLS_SIDE, .z = PYRAMID_NUM_CELLS_SIDE },
+                       terrain_vertices);
+    }
+}
+
+// update the pyramid after the terrain vertices have been shifted by num_chunks and refilled
+void update_height_pyramid(HeightPyramid* pyramid, const ivec3s num_chunks,
+                           const Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE])
+{
+    if (num_chunks.x == 0 && num_chunks.z == 0) {
+        return;
+    }
+
+    // the resident squares moved in the opposite direction of the vertices
+    pyramid->origin.x -= num_chunks.x;
+    pyramid->origin.z -= num_chunks.z;
+
+    // squares touching the new vertices on z
+    const ivec3s start_z = { .x = 0, .z = (num_chunks.z >= 0) ? 0 : PYRAMID_NUM_CELLS_SIDE + num_chunks.z };
+    const ivec3s end_z   = { .x = PYRAMID_NUM_CELLS_SIDE, .z = start_z.z + abs(num_chunks.z) };
+
+    // squares touching the new vertices on x
+    const ivec3s start_x = { .x = (num_chunks.x >= 0) ? 0 : PYRAMID_NUM_CELLS_SIDE + num_chunks.x, .z = 0 };
+    const ivec3s end_x   = { .x = start_x.x + abs(num_chunks.x), .z = PYRAMID_NUM_CELLS_SIDE };
+
+    // update one level at the time, each level is computed from the one below
+    for (int level = 0; level < PYRAMID_NUM_LEVELS; ++level) {
+        refresh_blocks(pyramid, level, start_z, end_z, terrain_vertices);
+        refresh_blocks(pyramid, level, start_x, end_x, terrain_vertices);
+
+        // blocks on the borders also lost the squares that were moved out of the terrain
+        if (level > 0) {
+            const int last = PYRAMID_NUM_CELLS_SIDE - 1;
+            refresh_blocks(pyramid, level, (ivec3s) { .x = 0, .z = 0 },    (ivec3s) { .x = PYRAMID_NUM_CELLS_SIDE, .z = 1 },
+                           terrain_vertices);
+            refresh_blocks(pyramid, level, (ivec3s) { .x = 0, .z = last }, (ivec3s) { .x = PYRAMID_NUM_CELLS_SIDE, .z = last + 1 },
+                           terrain_vertices);
+            refresh_blocks(pyramid, level, (ivec3s) { .x = 0, .z = 0 },    (ivec3s) { .x = 1, .z = PYRAMID_NUM_CELLS_SIDE },
+                           terrain_vertices);
+            refresh_blocks(pyramid, level, (ivec3s) { .x = last, .z = 0 }, (ivec3s) { .x = last + 1, .z = PYRAMID_NUM_CELLS_SIDE },
+                           terrain_vertices);
+        }
+    }
+}
+
+// initialize a ray to traverse the terrain grid
+static GridRay make_grid_ray(const vec3s origin, const vec3s direction, const float min_distance, const float max_distance,
+                             const Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE])
+{
+    // the grid starts at the first resident vertex, x grows with the columns and z decreases with the rows
+    const Vertex first = terrain_vertices[0];
+
+    const GridRay ray = {
+        .origin           = origin,
+        .direction        = direction,
+        .direction_length = sqrtf((direction.x * direction.x) + (direction.y * direction.y) + (direction.z * direction.z)),
+
+        .grid_origin    = { (origin.x - first.coords[0]) / TERRAIN_CHUNK_SIZE, (first.coords[2] - origin.z) / TERRAIN_CHUNK_SIZE },
+        .grid_direction = { direction.x / TERRAIN_CHUNK_SIZE, -direction.z / TERRAIN_CHUNK_SIZE },
+
+        .min_distance = min_distance,
+        .max_distance = max_distance
+    };
+
+    return ray;
+}
+
+// determine the distances at which the ray enters and exits an area of the grid, in squares from the first resident one
+static bool clip_grid_ray(const GridRay* ray, const ivec3s matrix_start, const ivec3s matrix_end, float* enter, float* exit)
+{
+    const float starts[2] = { matrix_start.x, matrix_start.z };
+    const float ends[2]   = { matrix_end.x, matrix_end.z };
+
+    *enter = ray->min_distance;
+    *exit  = ray->max_distance;
+
+    for (size_t axis = 0; axis < 2; ++axis) {
+        // a ray parallel to the axis is either always or never inside the area
+        if (fabsf(ray->grid_direction[axis]) <= FLT_EPSILON * ray->direction_length) {
+            if (ray->grid_origin[axis] < starts[axis] || ray->grid_origin[axis] > ends[axis]) {
+                return false;
+            }
+            continue;
+        }
+
+        float near = (starts[axis] - ray->grid_origin[axis]) / ray->grid_direction[axis];
+        float far  = (ends[axis]   - ray->grid_origin[axis]) / ray->grid_direction[axis];
+        if (near > far) {
+            glm_swapf(&near, &far);
+        }
+
+        *enter = glm_max(*enter, near);
+        *exit  = glm_min(*exit, far);
+    }
+
+    return *enter <= *exit;
+}
+
+// intersect the ray with a triangle, using the Moller-Trumbore algorithm
+static bool intersect_triangle(const GridRay* ray, Vertex v1, Vertex v2, Vertex v3, float* distance)
+{
+    vec3 edge1, edge2, ray_cross_edge2, origin_offset, offset_cross_edge1;
+    vec3s origin = ray->origin, direction = ray->direction;
+
+    // get the vectors of two edges of the triangle
+    glm_vec3_sub(v2.coords, v1.coords, edge1);
+    glm_vec3_sub(v3.coords, v1.coords, edge2);
+
+    // the ray is parallel to the triangle, relative to the lengths the determinant is the product of
+    glm_vec3_cross(direction.raw, edge2, ray_cross_edge2);
+    const float determinant = glm_vec3_dot(edge1, ray_cross_edge2);
+    if (fabsf(determinant) <= FLT_EPSILON * ray->direction_length * glm_vec3_norm(edge1) * glm_vec3_norm(edge2)) {
+        return false;
+    }
+
+    // determine the barycentric coordinates of the intersection with the triangle plane
+    glm_vec3_sub(origin.raw, v1.coords, origin_offset);
+    const float u = glm_vec3_dot(origin_offset, ray_cross_edge2) / determinant;
+    if (u < 0 || u > 1) {
+        return false;
+    }
+
+    glm_vec3_cross(origin_offset, edge1, offset_cross_edge1);
+    const float v = glm_vec3_dot(direction.raw, offset_cross_edge1) / determinant;
+    if (v < 0 || u + v > 1) {
+        return false;
+    }
+
+    // determine the distance along the ray
+    const float t = glm_vec3_dot(edge2, offset_cross_edge1) / determinant;
+    if (t < ray->min_distance || t > ray->max_distance) {
+        return false;
+    }
+
+    *distance = t;
+    return true;
+}
+
+// intersect the ray with the two triangles of a square, in squares from the first resident one
+static bool intersect_square(const GridRay* ray, const int square_x, const int square_z,
+                             const Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE], float* distance)
+{
+    const size_t current_pos = (square_z * TERRAIN_NUM_VERTICES_SIDE) + square_x;
+
+    // get the vertices of the square
+    const Vertex vertex      = terrain_vertices[current_pos];
+    const Vertex right       = terrain_vertices[current_pos + 1];
+    const Vertex below       = terrain_vertices[current_pos + TERRAIN_NUM_VERTICES_SIDE];
+    const Vertex below_right = terrain_vertices[current_pos + TERRAIN_NUM_VERTICES_SIDE + 1];
+
+    // bottom left and top right triangle faces, as they are drawn
+    float bottom_left_distance, top_right_distance;
+    const bool bottom_left_hit = intersect_triangle(ray, below, vertex, below_right, &bottom_left_distance);
+    const bool top_right_hit   = intersect_triangle(ray, vertex, right, below_right, &top_right_distance);
+
+    if (bottom_left_hit && top_right_hit) {
+        *distance = glm_min(bottom_left_distance, top_right_distance);
+    } else if (bottom_left_hit) {
+        *distance = bottom_left_distance;
+    } else if (top_right_hit) {
+        *distance = top_right_distance;
+    }
+
+    return bottom_left_hit || top_right_hit;
+}
+
+// find the closest intersection of the ray with the terrain inside the given blocks of a level
+static bool traverse_blocks(const HeightPyramid* pyramid, const GridRay* ray, const int level,
+                            const ivec3s blocks[], const size_t num_blocks,
+                            const Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE], float* distance)
+{
+    const ivec3s origin = pyramid->origin;
+    const int block_size = 1 << level;
+    ivec3s sorted_blocks[PYRAMID_LEVEL_SIZE(PYRAMID_NUM_LEVELS - 1)];
+    float sorted_enters[PYRAMID_LEVEL_SIZE(PYRAMID_NUM_LEVELS - 1)];
+    size_t num_sorted = 0;
+
+    for (size_t i = 0; i < num_blocks; ++i) {
+        // get the resident part of the block, in squares from the first resident one
+        const ivec3s start = { .x = glm_imax(blocks[i].x * block_size, origin.x) - origin.x,
+                               .z = glm_imax(blocks[i].z * block_size, origin.z) - origin.z };
+        const ivec3s end   = { .x = glm_imin((blocks[i].x + 1) * block_size, origin.x + PYRAMID_NUM_CELLS_SIDE) - origin.x,
+                               .z = glm_imin((blocks[i].z + 1) * block_size, origin.z + PYRAMID_NUM_CELLS_SIDE) - origin.z };
+        if (start.x >= end.x || start.z >= end.z) {
+            continue;
+        }
+
+        // skip the block if the ray does not cross it
+        float enter, exit;
+        if (!clip_grid_ray(ray, start, end, &enter, &exit)) {
+            continue;
+        }
+
+        // skip the block if the ray is entirely above or below it
+        const HeightRange range = pyramid->ranges[range_index(level, blocks[i].x, blocks[i].z)];
+        const float height_enter = ray->origin.y + (ray->direction.y * enter);
+        const float height_exit  = ray->origin.y + (ray->direction.y * exit);
+        if (glm_min(height_enter, height_exit) > range.max || glm_max(height_enter, height_exit) < range.min) {
+            continue;
+        }
+
+        // keep the blocks sorted by the distance at which the ray enters them
+        size_t j = num_sorted++;
+        for (; j > 0 && sorted_enters[j - 1] > enter; --j) {
+            sorted_blocks[j] = sorted_blocks[j - 1];
+            sorted_enters[j] = sorted_enters[j - 1];
+        }
+        sorted_blocks[j] = blocks[i];
+        sorted_enters[j] = enter;
+    }
+
+    // visit the blocks front to back, the first intersection found is the closest one
+    for (size_t i = 0; i < num_sorted; ++i) {
+        if (level == 0) {
+            if (intersect_square(ray, sorted_blocks[i].x - origin.x, sorted_blocks[i].z - origin.z, terrain_vertices, distance)) {
+                return true;
+            }
+        } else {
+            const ivec3s children[4] = {
+                { .x = (sorted_blocks[i].x * 2),     .z = (sorted_blocks[i].z * 2)     },
+                { .x = (sorted_blocks[i].x * 2) + 1, .z = (sorted_blocks[i].z * 2)     },
+                { .x = (sorted_blocks[i].x * 2),     .z = (sorted_blocks[i].z * 2) + 1 },
+                { .x = (sorted_blocks[i].x * 2) + 1, .z = (sorted_blocks[i].z * 2) + 1 },
+            };
+
+            if (traverse_blocks(pyramid, ray, level - 1, children, 4, terrain_vertices, distance)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// get the resident blocks of the top level, where every traversal starts
+static size_t get_top_blocks(const HeightPyramid* pyramid, ivec3s top_blocks[PYRAMID_LEVEL_SIZE(PYRAMID_NUM_LEVELS - 1)])
+{
+    const int level = PYRAMID_NUM_LEVELS - 1;
+    size_t num_top_blocks = 0;
+
+    for (int block_z = floor_shift(pyramid->origin.z, level);
+         block_z <= floor_shift(pyramid->origin.z + PYRAMID_NUM_CELLS_SIDE - 1, level); ++block_z) {
+        for (int block_x = floor_shift(pyramid->origin.x, level);
+             block_x <= floor_shift(pyramid->origin.x + PYRAMID_NUM_CELLS_SIDE - 1, level); ++block_x) {
+            top_blocks[num_top_blocks++] = (ivec3s) { .x = block_x, .z = block_z };
+        }
+    }
+
+    return num_top_blocks;
+}
+
+// find the closest intersection of each ray with the terrain
+void cast_rays(const HeightPyramid* pyramid, const Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE],
+               const Ray rays[], const size_t num_rays, RayHit hits[])
+{
+    ivec3s top_blocks[PYRAMID_LEVEL_SIZE(PYRAMID_NUM_LEVELS - 1)];
+    const size_t num_top_blocks = get_top_blocks(pyramid, top_blocks);
+
+    for (size_t i = 0; i < num_rays; ++i) {
+        const GridRay ray = make_grid_ray(rays[i].origin, rays[i].direction, 0, rays[i].max_distance, terrain_vertices);
+        float distance = 0;
+
+        hits[i].hit = traverse_blocks(pyramid, &ray, PYRAMID_NUM_LEVELS - 1, top_blocks, num_top_blocks, terrain_vertices, &distance);
+        hits[i].distance = distance;
+        hits[i].coords = (vec3s) { .x = rays[i].origin.x + (rays[i].direction.x * distance),
+                                   .y = rays[i].origin.y + (rays[i].direction.y * distance),
+                                   .z = rays[i].origin.z + (rays[i].direction.z * distance) };
+    }
+}
+
+// determine for each segment whether the terrain does not block the view between its two ends
+void check_visibility(const HeightPyramid* pyramid, const Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE],
+                      const vec3s from[], const vec3s to[], const size_t num_segments, bool visible[])
+{
+    ivec3s top_blocks[PYRAMID_LEVEL_SIZE(PYRAMID_NUM_LEVELS - 1)];
+    const size_t num_top_blocks = get_top_blocks(pyramid, top_blocks);
+
+    for (size_t i = 0; i < num_segments; ++i) {
+        const vec3s direction = { .x = to[i].x - from[i].x, .y = to[i].y - from[i].y, .z = to[i].z - from[i].z };
+        const GridRay ray = make_grid_ray(from[i], direction, VISIBILITY_EPSILON, 1 - VISIBILITY_EPSILON, terrain_vertices);
+        float distance;
+
+        visible[i] = !traverse_blocks(pyramid, &ray, PYRAMID_NUM_LEVELS - 1, top_blocks, num_top_blocks, terrain_vertices, &distance);
+    }
+}
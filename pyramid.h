@@ -0,0 +1,58 @@
+#ifndef PROCEDURAL_TERRAIN_GENERATION_PYRAMID_H
+#define PROCEDURAL_TERRAIN_GENERATION_PYRAMID_H
+
+#include <stdbool.h>
+
+#include "terrain.h"
+
+#define PYRAMID_NUM_CELLS_SIDE (TERRAIN_NUM_VERTICES_SIDE - 1)  // number of terrain squares in each axis
+#define PYRAMID_NUM_LEVELS     10  // number of levels, each block covers 2x2 blocks of the level below
+#define PYRAMID_LEVEL_SIDE(level) ((PYRAMID_NUM_CELLS_SIDE >> (level)) + 2)  // blocks stored in each axis, including the partial ones on the borders
+#define PYRAMID_LEVEL_SIZE(level) (PYRAMID_LEVEL_SIDE(level) * PYRAMID_LEVEL_SIDE(level))
+#define PYRAMID_MAX_LEVELS     12  // number of levels PYRAMID_LEVEL_OFFSET can sum, more than a terrain side can halve into
+#define PYRAMID_LEVEL_SIZE_BELOW(level, below) (((below) < (level)) ? PYRAMID_LEVEL_SIZE(below) : 0)
+#define PYRAMID_LEVEL_OFFSET(level) (PYRAMID_LEVEL_SIZE_BELOW(level, 0) + PYRAMID_LEVEL_SIZE_BELOW(level, 1) + \
+                                     PYRAMID_LEVEL_SIZE_BELOW(level, 2) + PYRAMID_LEVEL_SIZE_BELOW(level, 3) + \
+                                     PYRAMID_LEVEL_SIZE_BELOW(level, 4) + PYRAMID_LEVEL_SIZE_BELOW(level, 5) + \
+                                     PYRAMID_LEVEL_SIZE_BELOW(level, 6) + PYRAMID_LEVEL_SIZE_BELOW(level, 7) + \
+                                     PYRAMID_LEVEL_SIZE_BELOW(level, 8) + PYRAMID_LEVEL_SIZE_BELOW(level, 9) + \
+                                     PYRAMID_LEVEL_SIZE_BELOW(level, 10) + PYRAMID_LEVEL_SIZE_BELOW(level, 11))  // ranges stored before a level
+#define PYRAMID_NUM_RANGES PYRAMID_LEVEL_OFFSET(PYRAMID_NUM_LEVELS)
+
+_Static_assert(PYRAMID_NUM_LEVELS <= PYRAMID_MAX_LEVELS, "PYRAMID_LEVEL_OFFSET does not sum the ranges of every level");
+
+typedef struct {
+    float min;
+    float max;
+} HeightRange;
+
+// min/max heights of the resident terrain, blocks are aligned to the world so that moving only changes the refilled ones
+typedef struct {
+    ivec3s origin;  // world grid coordinates of the first resident terrain square, on x and z
+    HeightRange ranges[PYRAMID_NUM_RANGES];
+} HeightPyramid;
+
+typedef struct {
+    vec3s origin;
+    vec3s direction;
+    float max_distance;  // in multiples of the direction length
+} Ray;
+
+typedef struct {
+    bool hit;
+    float distance;  // in multiples of the direction length
+    vec3s coords;
+} RayHit;
+
+void init_height_pyramid(HeightPyramid* pyramid, const Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE]);
+
+void update_height_pyramid(HeightPyramid* pyramid, const ivec3s num_chunks,
+                           const Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE]);
+
+void cast_rays(const HeightPyramid* pyramid, const Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE],
+               const Ray rays[], const size_t num_rays, RayHit hits[]);
+
+void check_visibility(const HeightPyramid* pyramid, const Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE],
+                      const vec3s from[], const vec3s to[], const size_t num_segments, bool visible[]);
+
+#endif //PROCEDURAL_TERRAIN_GENERATION_PYRAMID_H
@@ -0,0 +1,153 @@
+// Frozen copies of the scalar noise, vertex and normal generation, used by verify as the reference for the kernels
+// in perlin.c and terrain.c. Optimizing those kernels must not change this file.
+#include <cglm/cglm.h>
+#include <math.h>
+
+#include "reference.h"
+#include "perlin.h"
+
+// permutations of the gradients, as in perlin.c
+static const unsigned char permutations[] = {
+    151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,
+    8,99,37,240,21,10,23,190,6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,
+    35,11,32,57,177,33,88,237,149,56,87,174,20,125,136,171,168,68,175,74,165,71,
+    134,139,48,27,166,77,146,158,231,83,111,229,122,60,211,133,230,220,105,92,41,
+    55,46,245,40,244,102,143,54,65,25,63,161,1,216,80,73,209,76,132,187,208,89,
+    18,169,200,196,135,130,116,188,159,86,164,100,109,198,173,186,3,64,52,217,226,
+    250,124,123,5,202,38,147,118,126,255,82,85,212,207,206,59,227,47,16,58,17,182,
+    189,28,42,223,183,170,213,119,248,152,2,44,154,163,70,221,153,101,155,167,43,
+    172,9,129,22,39,253,19,98,108,110,79,113,224,232,178,185,112,104,218,246,97,
+    228,251,34,242,193,238,210,144,12,191,179,162,241,81,51,145,235,249,14,239,107,
+    49,192,214,31,181,199,106,157,184,84,204,176,115,121,50,45,127,4,150,254,
+    138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
+};
+
+// terrain types, as in terrain.c
+static const TerrainType terrain_types[TERRAIN_NUM_TYPES] = {
+        {.color = (vec3s){0.20, 0.40, 0.75}, .shininess = 150.0f, .height = TERRAIN_SEA_LEVEL},         // blue - water
+        {.color = (vec3s){1.00, 1.00, 0.60}, .shininess = 50.00f, .height = TERRAIN_MAX_HEIGHT * 0.1},  // yellow - sand
+        {.color = (vec3s){0.35, 0.65, 0.10}, .shininess = 10.00f, .height = TERRAIN_MAX_HEIGHT * 0.2},  // light green - thin grass
+        {.color = (vec3s){0.30, 0.60, 0.10}, .shininess = 10.00f, .height = TERRAIN_MAX_HEIGHT * 0.3},  // green - grass
+        {.color = (vec3s){0.25, 0.55, 0.10}, .shininess = 10.00f, .height = TERRAIN_MAX_HEIGHT * 0.4},  // dark green - thick grass
+        {.color = (vec3s){0.35, 0.25, 0.25}, .shininess = 25.00f, .height = TERRAIN_MAX_HEIGHT * 0.7},  // grey - rock
+        {.color = (vec3s){1.00, 1.00, 1.00}, .shininess = 25.00f, .height = TERRAIN_MAX_HEIGHT},        // white - snow
+};
+
+// get gradient from integer coordinates, the conversion to unsigned char wraps negative remainders into [0, 256)
+static unsigned char reference_gradient(const int x, const int y)
+{
+    const unsigned char index_y = (y + seed) % 256;
+    const unsigned char index_x = (permutations[index_y] + x) % 256;
+
+    return permutations[index_x];
+}
+
+// compute 2-dimensional perlin noise at coordinates x, y
+static float reference_perlin_noise(const float x, const float y)
+{
+    // determine point cell coordinates
+    const int x_int = floor(x);
+    const int y_int = floor(y);
+
+    // get gradients from grid cell coordinates
+    const unsigned char top_left     = reference_gradient(x_int    , y_int);
+    const unsigned char top_right    = reference_gradient(x_int + 1, y_int);
+    const unsigned char bottom_left  = reference_gradient(x_int    , y_int + 1);
+    const unsigned char bottom_right = reference_gradient(x_int + 1, y_int + 1);
+
+    // determine interpolation weights
+    const float x_dec = x - x_int;
+    const float y_dec = y - y_int;
+
+    // interpolate between grid point gradients
+    const float top    = glm_smoothinterp(top_left, top_right, x_dec);
+    const float bottom = glm_smoothinterp(bottom_left, bottom_right, x_dec);
+
+    return glm_smoothinterp(top, bottom, y_dec);
+}
+
+// compute a fractal pattern as a sum of noise layers
+float reference_fractal_noise(const float x, const float y, float freq, const int octaves)
+{
+    const float lacunarity = 2.0;
+    const float gain = 0.5;
+    float fractal = 0.0;
+    float amp = gain;
+
+    for (int i = 0; i < octaves; ++i) {
+        fractal += reference_perlin_noise(x * freq, y * freq) * amp;
+        freq *= lacunarity;
+        amp *= gain;
+    }
+
+    return fractal / 256;
+}
+
+// initialize a single vertex values given x and z coordinates
+Vertex reference_generate_vertex(const ivec3s pos)
+{
+    // generate a height value between -TERRAIN_MAX_HEIGHT and TERRAIN_MAX_HEIGHT, with perlin noise
+    const float height = ((reference_fractal_noise(pos.x / TERRAIN_SCALE, pos.z / TERRAIN_SCALE, 1, 5) * 2) - 1) * TERRAIN_MAX_HEIGHT;
+
+    // determine vertex color and shininess by the vertex height
+    size_t terrain_type_i = 0;
+    for (; terrain_type_i < TERRAIN_NUM_TYPES; ++terrain_type_i) {
+        if (height <= terrain_types[terrain_type_i].height) {
+            break;
+        }
+    }
+
+    const Vertex vertex = {
+        .coords = {
+            pos.x,
+            glm_max(height, TERRAIN_SEA_LEVEL),
+            pos.z,
+        },
+
+        .normal = {0, 0, 0},
+
+        .color     = terrain_types[terrain_type_i].color,
+        .shininess = terrain_types[terrain_type_i].shininess
+    };
+
+    return vertex;
+}
+
+// add the normals of the triangles in the given squares to their vertices, then normalize the vertices normals
+void reference_fill_terrain_normals(const ivec3s matrix_start, const ivec3s matrix_end,
+                                    unsigned int terrain_indices[TERRAIN_NUM_VERTICES_SIDE - 1][TERRAIN_NUM_INDICES_X],
+                                    Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE])
+{
+    // convert from number of squares to number of indices, without reading past the last triangle of a row
+    const size_t matrix_start_x_indices = matrix_start.x * NUM_TRIANGLES_IN_SQUARE * NUM_VERTICES_IN_TRIANGLE;
+    const size_t row_end_x_indices      = glm_imin(matrix_end.x * NUM_TRIANGLES_IN_SQUARE * NUM_VERTICES_IN_TRIANGLE,
+                                                   TERRAIN_NUM_INDICES_X - (NUM_VERTICES_IN_TRIANGLE - 1));
+
+    // a triangle starts at every index of the row
+    for (int j = matrix_start.z; j < matrix_end.z - 1; ++j) {
+        for (size_t i = matrix_start_x_indices; i < row_end_x_indices; ++i) {
+            const size_t v1_index = terrain_indices[j][i    ];
+            const size_t v2_index = terrain_indices[j][i + 1];
+            const size_t v3_index = terrain_indices[j][i + 2];
+            Vertex v1 = terrain_vertices[v1_index];
+            Vertex v2 = terrain_vertices[v2_index];
+            Vertex v3 = terrain_vertices[v3_index];
+            vec3 edge1, edge2, normal;
+
+            glm_vec3_sub(v2.coords, v1.coords, edge1);
+            glm_vec3_sub(v3.coords, v1.coords, edge2);
+            glm_vec3_cross(edge1, edge2, normal);
+
+            // add the normal to the values read before the update, as terrain.c does
+            glm_vec3_add(normal, v1.normal, terrain_vertices[v1_index].normal);
+            glm_vec3_add(normal, v2.normal, terrain_vertices[v2_index].normal);
+            glm_vec3_add(normal, v3.normal, terrain_vertices[v3_index].normal);
+        }
+    }
+
+    for (int j = matrix_start.z; j < matrix_end.z; ++j) {
+        for (int i = matrix_start.x; i < matrix_end.x; ++i) {
+            glm_normalize(terrain_vertices[(j * TERRAIN_NUM_VERTICES_SIDE) + i].normal);
+        }
+    }
+}
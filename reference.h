@@ -0,0 +1,14 @@
+#ifndef PROCEDURAL_TERRAIN_GENERATION_REFERENCE_H
+#define PROCEDURAL_TERRAIN_GENERATION_REFERENCE_H
+
+#include "terrain.h"
+
+float reference_fractal_noise(const float x, const float y, float freq, const int octaves);
+
+Vertex reference_generate_vertex(const ivec3s pos);
+
+void reference_fill_terrain_normals(const ivec3s matrix_start, const ivec3s matrix_end,
+                                    unsigned int terrain_indices[TERRAIN_NUM_VERTICES_SIDE - 1][TERRAIN_NUM_INDICES_X],
+                                    Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE]);
+
+#endif //PROCEDURAL_TERRAIN_GENERATION_REFERENCE_H
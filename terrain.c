@@ -1,5 +1,4 @@
 #include <cglm/cglm.h>
-#include <GL/glew.h>
 
 #include "terrain.h"
 #include "perlin.h"
@@ -15,8 +14,11 @@ static const TerrainType terrain_types[TERRAIN_NUM_TYPES] = {
         {.color = (vec3s){1.00, 1.00, 1.00}, .shininess = 25.00f, .height = TERRAIN_MAX_HEIGHT},        // white - snow
 };
 
+// world coordinates of the first terrain vertex, moved by whole chunks so that the terrain stays a regular grid
+static ivec3s world_start;
+
 // initialize a single vertex values given x and z coordinates
-static Vertex generate_vertex(const ivec3s pos)
+Vertex generate_vertex(const ivec3s pos)
 {
     // generate a height value between -TERRAIN_MAX_HEIGHT and TERRAIN_MAX_HEIGHT, with perlin noise
     const float height = ((fractal_noise(pos.x / TERRAIN_SCALE, pos.z / TERRAIN_SCALE, 1, 5) * 2) - 1) * TERRAIN_MAX_HEIGHT;
@@ -50,8 +52,6 @@ static Vertex generate_vertex(const ivec3s pos)
 static void fill_terrain_vertices(const ivec3s matrix_start, const ivec3s matrix_end,
                                   Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE])
 {
-    const ivec3s world_start = { .x = position.x + (TERRAIN_SIZE / 2), .z = position.z - (TERRAIN_SIZE / 2) };
-
     for (size_t j = matrix_start.z; j < matrix_end.z; ++j) {
         for (size_t i = matrix_start.x; i < matrix_end.x; ++i) {
             const ivec3s world_pos = { .x = - world_start.x + (i * TERRAIN_CHUNK_SIZE),
@@ -62,6 +62,22 @@ static void fill_terrain_vertices(const ivec3s matrix_start, const ivec3s matrix
     }
 }
 
+// get the parts of the terrain generated after moving by num_chunks, the rows new on z and then the columns new on x
+void get_terrain_update_strips(const ivec3s num_chunks, ivec3s start[TERRAIN_NUM_UPDATE_STRIPS], ivec3s end[TERRAIN_NUM_UPDATE_STRIPS])
+{
+    // rows new on z
+    start[0].x = 0;
+    end[0].x   = TERRAIN_NUM_VERTICES_SIDE;
+    start[0].z = (num_chunks.z >= 0) ? 0 : TERRAIN_NUM_VERTICES_SIDE + num_chunks.z;
+    end[0].z   = start[0].z + abs(num_chunks.z);
+
+    // columns new on x, in the rows left
+    start[1].x = (num_chunks.x >= 0) ? 0 : TERRAIN_NUM_VERTICES_SIDE + num_chunks.x;
+    end[1].x   = start[1].x + abs(num_chunks.x);
+    start[1].z = end[0].z % TERRAIN_NUM_VERTICES_SIDE;
+    end[1].z   = start[1].z + (TERRAIN_NUM_VERTICES_SIDE - abs(num_chunks.z));
+}
+
 // update terrain vertices
 void update_terrain_vertices(const ivec3s num_chunks, Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE])
 {
@@ -69,6 +85,10 @@ void update_terrain_vertices(const ivec3s num_chunks, Vertex terrain_vertices[TE
     const ivec3s diff_shift = { .x = TERRAIN_NUM_VERTICES_SIDE - abs(num_chunks.x), .z = TERRAIN_NUM_VERTICES_SIDE - abs(num_chunks.z)};
     ivec3s start, end;
 
+    // move the terrain by the same whole chunks the vertices are shifted by
+    world_start.x += num_chunks.x * TERRAIN_CHUNK_SIZE;
+    world_start.z -= num_chunks.z * TERRAIN_CHUNK_SIZE;
+
     // determine variables values to shift on x
     start.x = (num_chunks.x >= 0) ? (diff_shift.x - 1) : abs(num_chunks.x);
     end.x   = start.x - (diff_shift.x * sign.x);
@@ -96,19 +116,26 @@ void update_terrain_vertices(const ivec3s num_chunks, Vertex terrain_vertices[TE
         }
     }
 
-    // generate new vertices on z
-    start.x = 0;
-    end.x   = TERRAIN_NUM_VERTICES_SIDE;
-    start.z = (num_chunks.z >= 0) ? 0 : TERRAIN_NUM_VERTICES_SIDE + num_chunks.z;
-    end.z   = start.z + abs(num_chunks.z);
-    fill_terrain_vertices(start, end, terrain_vertices);
-
-    // generate new vertices on x
-    start.x = (num_chunks.x >= 0) ? 0 : TERRAIN_NUM_VERTICES_SIDE + num_chunks.x;
-    end.x   = start.x + abs(num_chunks.x);
-    start.z = end.z % TERRAIN_NUM_VERTICES_SIDE;
-    end.z   = start.z + diff_shift.z;
-    fill_terrain_vertices(start, end, terrain_vertices);
+    // generate new vertices on z and on x
+    ivec3s strips_start[TERRAIN_NUM_UPDATE_STRIPS], strips_end[TERRAIN_NUM_UPDATE_STRIPS];
+    get_terrain_update_strips(num_chunks, strips_start, strips_end);
+    for (size_t i = 0; i < TERRAIN_NUM_UPDATE_STRIPS; ++i) {
+        fill_terrain_vertices(strips_start[i], strips_end[i], terrain_vertices);
+    }
+}
+
+// fill the indices of the two triangles of the square whose top left vertex is at current_pos
+static void fill_square_indices(const unsigned int current_pos, unsigned int square_indices[TERRAIN_NUM_INDICES_SQUARE])
+{
+    // bottom left triangle face
+    square_indices[0] = current_pos + TERRAIN_NUM_VERTICES_SIDE;      // vertex below
+    square_indices[1] = current_pos;                                  // vertex
+    square_indices[2] = current_pos + TERRAIN_NUM_VERTICES_SIDE + 1;  // vertex below to the right
+
+    // top right triangle face
+    square_indices[3] = current_pos;                                  // vertex
+    square_indices[4] = current_pos + 1;                              // vertex to the right
+    square_indices[5] = current_pos + TERRAIN_NUM_VERTICES_SIDE + 1;  // vertex below to the right
 }
 
 // fill the terrain array of indices
@@ -118,16 +145,8 @@ static void fill_terrain_indices(unsigned int terrain_indices[TERRAIN_NUM_VERTIC
         int current_pos = j * TERRAIN_NUM_VERTICES_SIDE;
 
         // compute the indices of all vertices, two triangles at the time
-        for (size_t i = 0; i < TERRAIN_NUM_INDICES_X; i += 6) {
-            // bottom left triangle face
-            terrain_indices[j][i    ] = current_pos + TERRAIN_NUM_VERTICES_SIDE;      // vertex below
-            terrain_indices[j][i + 1] = current_pos;                                  // vertex
-            terrain_indices[j][i + 2] = current_pos + TERRAIN_NUM_VERTICES_SIDE + 1;  // vertex below to the right
-
-            // top right triangle face
-            terrain_indices[j][i + 3] = current_pos;                                  // vertex
-            terrain_indices[j][i + 4] = current_pos + 1;                              // vertex to the right
-            terrain_indices[j][i + 5] = current_pos + TERRAIN_NUM_VERTICES_SIDE + 1;  // vertex below to the right
+        for (size_t i = 0; i < TERRAIN_NUM_INDICES_X; i += TERRAIN_NUM_INDICES_SQUARE) {
+            fill_square_indices(current_pos, &terrain_indices[j][i]);
 
             ++current_pos;  // new current starting position every two triangles
         }
@@ -135,17 +154,20 @@ static void fill_terrain_indices(unsigned int terrain_indices[TERRAIN_NUM_VERTIC
 }
 
 // fill the terrain array of normals
-static void fill_terrain_normals(const ivec3s matrix_start, const ivec3s matrix_end,
-                                 unsigned int terrain_indices[TERRAIN_NUM_VERTICES_SIDE - 1][TERRAIN_NUM_INDICES_X],
-                                 Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE])
+void fill_terrain_normals(const ivec3s matrix_start, const ivec3s matrix_end,
+                          unsigned int terrain_indices[TERRAIN_NUM_VERTICES_SIDE - 1][TERRAIN_NUM_INDICES_X],
+                          Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE])
 {
     // convert from number of squares to number of indices
     const size_t matrix_start_x_indices = matrix_start.x * NUM_TRIANGLES_IN_SQUARE * NUM_VERTICES_IN_TRIANGLE;
     const size_t matrix_end_x_indices   = matrix_end.x   * NUM_TRIANGLES_IN_SQUARE * NUM_VERTICES_IN_TRIANGLE;
 
+    // the last triangle of a row starts three indices before its end, do not read past it
+    const size_t row_end_x_indices = glm_imin(matrix_end_x_indices, TERRAIN_NUM_INDICES_X - (NUM_VERTICES_IN_TRIANGLE - 1));
+
     // compute the normals of all vertices, one triangle at the time
-    for (size_t j = matrix_start.z; j < matrix_end.z - 1; ++j) {
-        for (size_t i = matrix_start_x_indices; i < matrix_end_x_indices; ++i) {
+    for (size_t j = matrix_start.z; j + 1 < matrix_end.z; ++j) {
+        for (size_t i = matrix_start_x_indices; i < row_end_x_indices; ++i) {
             vec3 edge1, edge2, normal;
 
             // get the indices of the triangle
@@ -185,45 +207,47 @@ void update_terrain_normals(const ivec3s num_chunks,
                             unsigned int terrain_indices[TERRAIN_NUM_VERTICES_SIDE - 1][TERRAIN_NUM_INDICES_X],
                             Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE])
 {
-    ivec3s start, end;
+    ivec3s strips_start[TERRAIN_NUM_UPDATE_STRIPS], strips_end[TERRAIN_NUM_UPDATE_STRIPS];
 
-    // update normals on z
-    start.x = 0;
-    end.x   = TERRAIN_NUM_VERTICES_SIDE;
-    start.z = (num_chunks.z >= 0) ? 0 : TERRAIN_NUM_VERTICES_SIDE + num_chunks.z;
-    end.z   = start.z + abs(num_chunks.z);
-    fill_terrain_normals(start, end, terrain_indices, terrain_vertices);
-
-    // update normals on x
-    start.x = (num_chunks.x >= 0) ? 0 : TERRAIN_NUM_VERTICES_SIDE + num_chunks.x;
-    end.x   = start.x + abs(num_chunks.x);
-    start.z = end.z % TERRAIN_NUM_VERTICES_SIDE;
-    end.z   = start.z + (TERRAIN_NUM_VERTICES_SIDE - abs(num_chunks.z));
-    fill_terrain_normals(start, end, terrain_indices, terrain_vertices);
+    // update normals on z and on x
+    get_terrain_update_strips(num_chunks, strips_start, strips_end);
+    for (size_t i = 0; i < TERRAIN_NUM_UPDATE_STRIPS; ++i) {
+        fill_terrain_normals(strips_start[i], strips_end[i], terrain_indices, terrain_vertices);
+    }
 }
 
-// fill the terrain array of counts
-static void fill_terrain_counts(int terrain_counts[TERRAIN_NUM_VERTICES_SIDE - 1])
+// fill the terrain array of indices to draw, as a list of triangles ordered in vertical tiles of tile_size squares
+// so that the vertices shared with the previous row are still in the post-transform vertex cache when reused
+void fill_terrain_draw_indices(size_t tile_size, unsigned int terrain_draw_indices[TERRAIN_NUM_DRAW_INDICES])
 {
-    for (size_t i = 0; i < TERRAIN_NUM_VERTICES_SIDE - 1; ++i) {
-        terrain_counts[i] = TERRAIN_NUM_INDICES_X;
+    size_t index = 0;
+
+    // tiles are at least one square wide
+    if (tile_size < 1) {
+        tile_size = 1;
     }
-}
 
-// fill the terrain array of offsets
-static void fill_terrain_offsets(void* terrain_offsets[TERRAIN_NUM_VERTICES_SIDE - 1])
-{
-    for (size_t i = 0; i < TERRAIN_NUM_VERTICES_SIDE - 1; ++i) {
-        terrain_offsets[i] = (GLvoid *) (TERRAIN_NUM_INDICES_X * i * sizeof(unsigned int));
+    for (size_t tile_start = 0; tile_start < TERRAIN_NUM_VERTICES_SIDE - 1; tile_start += tile_size) {
+        const size_t tile_end = (tile_start + tile_size < TERRAIN_NUM_VERTICES_SIDE - 1) ? tile_start + tile_size
+                                                                                        : TERRAIN_NUM_VERTICES_SIDE - 1;
+
+        // compute the indices of the tile, one row of squares at the time
+        for (size_t j = 0; j < TERRAIN_NUM_VERTICES_SIDE - 1; ++j) {
+            for (size_t i = tile_start; i < tile_end; ++i) {
+                fill_square_indices((j * TERRAIN_NUM_VERTICES_SIDE) + i, &terrain_draw_indices[index]);
+                index += TERRAIN_NUM_INDICES_SQUARE;
+            }
+        }
     }
 }
 
 // procedurally generate terrain
 void init_terrain(Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE],
                   unsigned int terrain_indices[TERRAIN_NUM_VERTICES_SIDE - 1][TERRAIN_NUM_INDICES_X],
-                  int terrain_counts[TERRAIN_NUM_VERTICES_SIDE - 1],
-                  void* terrain_offsets[TERRAIN_NUM_VERTICES_SIDE - 1])
+                  unsigned int terrain_draw_indices[TERRAIN_NUM_DRAW_INDICES])
 {
+    world_start = (ivec3s) { .x = position.x + (TERRAIN_SIZE / 2), .z = position.z - (TERRAIN_SIZE / 2) };
+
     fill_terrain_vertices((ivec3s) {0, 0, 0},
                           (ivec3s) {TERRAIN_NUM_VERTICES_SIDE, TERRAIN_NUM_VERTICES_SIDE, TERRAIN_NUM_VERTICES_SIDE},
                           terrain_vertices);
@@ -231,6 +255,5 @@ void init_terrain(Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NU
     fill_terrain_normals((ivec3s) {0, 0, 0},
                          (ivec3s) {TERRAIN_NUM_VERTICES_SIDE, TERRAIN_NUM_VERTICES_SIDE, TERRAIN_NUM_VERTICES_SIDE},
                          terrain_indices, terrain_vertices); // needs to always be after filling terrain vertices and indices
-    fill_terrain_counts(terrain_counts);
-    fill_terrain_offsets(terrain_offsets);
+    fill_terrain_draw_indices(TERRAIN_TILE_SIZE, terrain_draw_indices);
 }
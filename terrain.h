@@ -10,9 +10,14 @@
 #define TERRAIN_SCALE      65.5
 #define TERRAIN_NUM_TYPES  7    // number of different types of terrains
 #define TERRAIN_NUM_VERTICES_SIDE 650  // number of terrain's vertices in each axis
-#define TERRAIN_NUM_INDICES_X (NUM_VERTICES_IN_TRIANGLE * NUM_TRIANGLES_IN_SQUARE * (TERRAIN_NUM_VERTICES_SIDE - 1))
+#define TERRAIN_NUM_INDICES_SQUARE (NUM_VERTICES_IN_TRIANGLE * NUM_TRIANGLES_IN_SQUARE)  // number of indices to draw a square
+#define TERRAIN_NUM_INDICES_X (TERRAIN_NUM_INDICES_SQUARE * (TERRAIN_NUM_VERTICES_SIDE - 1))
+#define TERRAIN_NUM_DRAW_INDICES (TERRAIN_NUM_INDICES_X * (TERRAIN_NUM_VERTICES_SIDE - 1))
+#define TERRAIN_ROW_ORDER_TILE_SIZE (TERRAIN_NUM_VERTICES_SIDE - 1)  // set TERRAIN_TILE_SIZE to it to draw the terrain in plain row order
+#define TERRAIN_TILE_SIZE         4    // width in squares of the tiles the terrain is drawn in, needs a vertex cache of at least 2 * (size + 1) entries
 #define TERRAIN_CHUNK_SIZE        2    // the size of each chunk, the distance between two vertices in the same axis
 #define TERRAIN_SIZE (TERRAIN_NUM_VERTICES_SIDE * TERRAIN_CHUNK_SIZE)  // total size of terrain grid
+#define TERRAIN_NUM_UPDATE_STRIPS 2    // number of parts generated after a move, one on each axis
 
 extern vec3s position;  // current player position
 
@@ -24,8 +29,17 @@ typedef struct {
 
 void init_terrain(Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE],
                   unsigned int terrain_indices[TERRAIN_NUM_VERTICES_SIDE - 1][TERRAIN_NUM_INDICES_X],
-                  int terrain_counts[TERRAIN_NUM_VERTICES_SIDE - 1],
-                  void* terrain_offsets[TERRAIN_NUM_VERTICES_SIDE - 1]);
+                  unsigned int terrain_draw_indices[TERRAIN_NUM_DRAW_INDICES]);
+
+void fill_terrain_draw_indices(size_t tile_size, unsigned int terrain_draw_indices[TERRAIN_NUM_DRAW_INDICES]);
+
+Vertex generate_vertex(const ivec3s pos);
+
+void fill_terrain_normals(const ivec3s matrix_start, const ivec3s matrix_end,
+                          unsigned int terrain_indices[TERRAIN_NUM_VERTICES_SIDE - 1][TERRAIN_NUM_INDICES_X],
+                          Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE]);
+
+void get_terrain_update_strips(const ivec3s num_chunks, ivec3s start[TERRAIN_NUM_UPDATE_STRIPS], ivec3s end[TERRAIN_NUM_UPDATE_STRIPS]);
 
 void update_terrain_vertices(const ivec3s num_chunks, Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE]);
 
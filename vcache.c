@@ -0,0 +1,70 @@
+#include <stdbool.h>
+
+#include "vcache.h"
+
+// compute the average cache miss ratio, the number of vertex shader invocations per triangle,
+// of drawing a list of triangles with a post-transform vertex cache of the given size and policy
+float compute_acmr(const unsigned int* indices, const size_t num_indices, size_t cache_size, const VertexCachePolicy policy)
+{
+    // simulate a cache of at least one entry and never bigger than the available entries
+    if (cache_size < 1) {
+        cache_size = 1;
+    } else if (cache_size > VERTEX_CACHE_MAX_SIZE) {
+        cache_size = VERTEX_CACHE_MAX_SIZE;
+    }
+
+    // without triangles there is nothing to miss
+    if (num_indices < 3) {
+        return 0;
+    }
+
+    unsigned int cache[VERTEX_CACHE_MAX_SIZE];
+    size_t cache_used = 0;  // number of entries of the cache currently filled
+    size_t cache_next = 0;  // next entry to replace when the FIFO cache is full
+    size_t num_misses = 0;
+
+    for (size_t i = 0; i < num_indices; ++i) {
+        // look for the vertex in the cache
+        size_t entry = 0;
+        for (; entry < cache_used; ++entry) {
+            if (cache[entry] == indices[i]) {
+                break;
+            }
+        }
+        const bool is_hit = entry < cache_used;
+
+        if (!is_hit) {
+            ++num_misses;
+        }
+
+        if (policy == VERTEX_CACHE_FIFO) {
+            if (is_hit) {
+                continue;
+            }
+
+            // add the vertex, replacing the oldest one when the cache is full
+            if (cache_used < cache_size) {
+                cache[cache_used++] = indices[i];
+            } else {
+                cache[cache_next] = indices[i];
+                cache_next = (cache_next + 1) % cache_size;
+            }
+        } else {
+            // on a miss, drop the least recently used vertex when the cache is full
+            if (!is_hit && cache_used < cache_size) {
+                ++cache_used;
+            }
+            if (entry >= cache_used) {
+                entry = cache_used - 1;
+            }
+
+            // move the vertex to the front, as the most recently used
+            for (; entry > 0; --entry) {
+                cache[entry] = cache[entry - 1];
+            }
+            cache[0] = indices[i];
+        }
+    }
+
+    return (float)num_misses / (num_indices / 3);
+}
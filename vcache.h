@@ -0,0 +1,15 @@
+#ifndef PROCEDURAL_TERRAIN_GENERATION_VCACHE_H
+#define PROCEDURAL_TERRAIN_GENERATION_VCACHE_H
+
+#include <stddef.h>
+
+#define VERTEX_CACHE_MAX_SIZE 64  // maximum number of entries of the simulated post-transform vertex cache
+
+typedef enum VertexCachePolicy {
+    VERTEX_CACHE_FIFO,  // the oldest transformed vertex is replaced, hits do not refresh entries
+    VERTEX_CACHE_LRU    // the least recently used transformed vertex is replaced
+} VertexCachePolicy;
+
+float compute_acmr(const unsigned int* indices, const size_t num_indices, size_t cache_size, const VertexCachePolicy policy);
+
+#endif //PROCEDURAL_TERRAIN_GENERATION_VCACHE_H
@@ -0,0 +1,551 @@
+// standard includes
+#include <cglm/cglm.h>
+#include <float.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// application specific includes
+#include "terrain.h"
+#include "perlin.h"
+#include "pyramid.h"
+#include "player.h"
+#include "reference.h"
+#include "vcache.h"
+
+// maximum differences allowed between the candidate kernels and the frozen scalar reference ones
+#define MAX_NOISE_ULP          4     // units in the last place of fractal_noise results
+#define MAX_HEIGHT_ERROR       1e-4  // absolute error of the vertex heights
+#define MAX_NORMAL_ERROR       1e-5  // absolute error of each component of the vertex normals
+#define MAX_BIOME_MISMATCHES   0     // vertices with a different color or shininess
+#define MAX_CENTER_OFFSET      TERRAIN_CHUNK_SIZE  // distance of the terrain center from the player after an update
+#define MAX_DISTANCE_ERROR     1e-3  // absolute error of the ray hit distances of the height pyramid
+#define MAX_ACMR_ERROR         0.01  // absolute error of the average cache miss ratio of the draw orders
+
+#define NUM_RANDOM_SAMPLES 20000  // random coordinates checked for each seed
+#define NUM_QUERIES        8      // rays and segments checked after each terrain update
+#define PYRAMID_CHECK_STEP 3      // number of terrain updates between two checks of the height pyramid
+#define ACMR_CACHE_SIZE    16     // entries of the post-transform vertex cache the draw orders are checked with
+#define SHORT_DIRECTION_SCALE 1e-8f  // length of the ray directions cast again to check that hits do not depend on it
+
+// candidate kernels checked against the frozen copies of the scalar code in reference.c, the ones used by the terrain
+// by default, point them at an optimized version to verify it before it replaces them
+static float (*const candidate_fractal_noise)(const float, const float, float, const int) = fractal_noise;
+static Vertex (*const candidate_generate_vertex)(const ivec3s) = generate_vertex;
+static void (*const candidate_fill_terrain_normals)(const ivec3s, const ivec3s,
+                                                    unsigned int[TERRAIN_NUM_VERTICES_SIDE - 1][TERRAIN_NUM_INDICES_X],
+                                                    Vertex[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE]) = fill_terrain_normals;
+
+// globals required by the terrain generation
+vec3s position;
+int seed;
+static float angle_rad_y;
+static vec3s position_last_update;
+
+// seeds checked, covering both ends of the range used by main.c
+static const int seeds[] = {0, 1, 255, 256, 1337, 4999};
+
+// golden hashes of the terrain after init_terrain and after replaying player_moves, recorded with the scalar code
+static const struct {
+    int seed;
+    uint64_t init_hash;
+    uint64_t moved_hash;
+} golden_hashes[] = {
+    {0,    0xcda278940112c92a, 0xc5824d71ec46b62d},
+    {1337, 0x89c6997be04b9c9e, 0x3f50fbf579675211},
+    {4999, 0x6ac526e6dfaca80d, 0x59354aaa17ce7b0e},
+};
+
+// keys pressed to move the player, with turns and fractional moves in every direction
+static const struct {
+    unsigned char key;
+    int repeat;
+} player_moves[] = {
+    {'w', 20}, {'d', 37}, {'w', 30}, {'a', 95}, {'s', 25}, {'w', 12}, {'a', 140}, {'w', 40}, {'d', 23}, {'s', 17},
+};
+
+// terrain data, with the same shape as in main.c
+static Vertex terrain_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE];
+static Vertex reference_vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE];
+static unsigned int terrain_indices[TERRAIN_NUM_VERTICES_SIDE - 1][TERRAIN_NUM_INDICES_X];
+static unsigned int terrain_draw_indices[TERRAIN_NUM_DRAW_INDICES];
+static unsigned int row_draw_indices[TERRAIN_NUM_DRAW_INDICES];     // the same triangles in plain row order
+static unsigned int sorted_triangles[2][TERRAIN_NUM_DRAW_INDICES];  // both orders, sorted to compare their triangles
+static HeightPyramid height_pyramid;          // updated incrementally while moving
+static HeightPyramid rebuilt_height_pyramid;  // built from scratch after every update
+
+// get a random float between min and max
+static float random_float(const float min, const float max)
+{
+    return min + ((max - min) * rand() / RAND_MAX);
+}
+
+// map a float to an integer that grows by one for each representable float
+static int64_t ordered_bits(const float value)
+{
+    int32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    return (bits < 0) ? (int64_t)INT32_MIN - bits : bits;
+}
+
+// get the number of representable floats between a and b
+static int64_t ulp_distance(const float a, const float b)
+{
+    return llabs(ordered_bits(a) - ordered_bits(b));
+}
+
+// hash the terrain vertices with 64-bit FNV-1a
+static uint64_t hash_vertices(const Vertex vertices[TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE])
+{
+    const unsigned char* bytes = (const unsigned char*)vertices;
+    uint64_t hash = 0xcbf29ce484222325;
+
+    for (size_t i = 0; i < sizeof(terrain_vertices); ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3;
+    }
+
+    return hash;
+}
+
+// update the terrain like the display loop in main.c, returns the number of chunks moved
+static ivec3s update_terrain(void)
+{
+    ivec3s num_chunks = { .x = 0, .z = 0 };
+
+    if (should_update_terrain(position_last_update)) {
+        num_chunks = get_num_chunks(&position_last_update);
+        update_terrain_vertices(num_chunks, terrain_vertices);
+        update_terrain_normals(num_chunks, terrain_indices, terrain_vertices);
+    }
+
+    return num_chunks;
+}
+
+// generate the terrain for a seed at the starting player position
+static void reset_terrain(const int new_seed)
+{
+    seed = new_seed;
+    angle_rad_y = 0;
+    position = (vec3s) { .x = 0, .y = -TERRAIN_MAX_HEIGHT - CAMERA_HEIGHT, .z = 0 };
+    position_last_update = position;
+
+    init_terrain(terrain_vertices, terrain_indices, terrain_draw_indices);
+}
+
+// compare the candidate fractal noise against the reference one, including negative coordinates and cell borders
+static bool check_fractal_noise(void)
+{
+    const float edge_coords[] = {0.0f, -0.0f, 1e-7f, -1e-7f, 0.5f, -0.5f, 0.999999f, -0.999999f, 1.0f, -1.0f,
+                                 255.0f, 255.5f, 256.0f, -255.5f, -256.0f, -257.0f, -4999.25f, -5000.75f, 12345.5f, -12345.5f};
+    const size_t num_edge_coords = sizeof(edge_coords) / sizeof(edge_coords[0]);
+    int64_t max_ulp = 0;
+    float max_error = 0;
+    size_t num_wrap_mismatches = 0;
+
+    for (size_t s = 0; s < sizeof(seeds) / sizeof(seeds[0]); ++s) {
+        seed = seeds[s];
+
+        // every pair of edge coordinates, with a single octave and with the octaves used by the terrain
+        for (size_t i = 0; i < num_edge_coords; ++i) {
+            for (size_t j = 0; j < num_edge_coords; ++j) {
+                for (int octaves = 1; octaves <= 5; octaves += 4) {
+                    const float reference = reference_fractal_noise(edge_coords[i], edge_coords[j], 1, octaves);
+                    const float candidate = candidate_fractal_noise(edge_coords[i], edge_coords[j], 1, octaves);
+
+                    const int64_t ulp = ulp_distance(reference, candidate);
+                    max_ulp   = (ulp > max_ulp) ? ulp : max_ulp;
+                    max_error = glm_max(max_error, fabsf(reference - candidate));
+                }
+            }
+        }
+
+        // random coordinates, as generated by the terrain
+        for (size_t i = 0; i < NUM_RANDOM_SAMPLES; ++i) {
+            const float x = random_float(-20000, 20000) / TERRAIN_SCALE;
+            const float y = random_float(-20000, 20000) / TERRAIN_SCALE;
+            const float reference = reference_fractal_noise(x, y, 1, 5);
+            const float candidate = candidate_fractal_noise(x, y, 1, 5);
+
+            const int64_t ulp = ulp_distance(reference, candidate);
+            max_ulp   = (ulp > max_ulp) ? ulp : max_ulp;
+            max_error = glm_max(max_error, fabsf(reference - candidate));
+        }
+
+        // the gradients repeat every 256 cells, also when the coordinates or the permutation index are negative
+        for (size_t i = 0; i < NUM_RANDOM_SAMPLES; ++i) {
+            const float x = (rand() % 256) + ((rand() % 4) * 0.25f);
+            const float y = (rand() % 256) + ((rand() % 4) * 0.25f);
+            const float x_wrapped = x - (256 * (1 + (rand() % 40)));
+            const float y_wrapped = y - (256 * (1 + (rand() % 40)));
+
+            if (ulp_distance(reference_fractal_noise(x, y, 1, 1), candidate_fractal_noise(x_wrapped, y_wrapped, 1, 1)) > MAX_NOISE_ULP) {
+                ++num_wrap_mismatches;
+            }
+        }
+    }
+
+    printf("fractal_noise:        max %lld ULP, max absolute error %g, %zu mismatches across the 256 cells wrap\n",
+           (long long)max_ulp, max_error, num_wrap_mismatches);
+
+    return max_ulp <= MAX_NOISE_ULP && num_wrap_mismatches == 0;
+}
+
+// compare the candidate vertex generation against the reference one
+static bool check_generate_vertex(void)
+{
+    const int edge_coords[] = {0, 1, -1, 2, -2, 65, -65, 66, -66, TERRAIN_SIZE, -TERRAIN_SIZE, 16768, -16768, 327680, -327680};
+    const size_t num_edge_coords = sizeof(edge_coords) / sizeof(edge_coords[0]);
+    float max_error = 0;
+    size_t num_biome_mismatches = 0;
+
+    for (size_t s = 0; s < sizeof(seeds) / sizeof(seeds[0]); ++s) {
+        seed = seeds[s];
+
+        for (size_t i = 0; i < (num_edge_coords * num_edge_coords) + NUM_RANDOM_SAMPLES; ++i) {
+            // start from every pair of edge coordinates, then continue with random ones
+            const ivec3s pos = (i < num_edge_coords * num_edge_coords)
+                ? (ivec3s) { .x = edge_coords[i % num_edge_coords], .z = edge_coords[i / num_edge_coords] }
+                : (ivec3s) { .x = (rand() % 200001) - 100000, .z = (rand() % 200001) - 100000 };
+
+            const Vertex reference = reference_generate_vertex(pos);
+            const Vertex candidate = candidate_generate_vertex(pos);
+
+            for (size_t axis = 0; axis < 3; ++axis) {
+                max_error = glm_max(max_error, fabsf(reference.coords[axis] - candidate.coords[axis]));
+            }
+            if (memcmp(&reference.color, &candidate.color, sizeof(reference.color)) != 0 ||
+                memcmp(&reference.shininess, &candidate.shininess, sizeof(reference.shininess)) != 0) {
+                ++num_biome_mismatches;
+            }
+        }
+    }
+
+    printf("generate_vertex:      max absolute error %g, %zu biome mismatches\n", max_error, num_biome_mismatches);
+
+    return max_error <= MAX_HEIGHT_ERROR && num_biome_mismatches <= MAX_BIOME_MISMATCHES;
+}
+
+// run the reference and candidate normals on the same squares of a copy of the terrain, returns the max error
+static float compare_normals(const ivec3s matrix_start[], const ivec3s matrix_end[], const size_t num_parts)
+{
+    float max_error = 0;
+
+    memcpy(reference_vertices, terrain_vertices, sizeof(terrain_vertices));
+    for (size_t i = 0; i < num_parts; ++i) {
+        reference_fill_terrain_normals(matrix_start[i], matrix_end[i], terrain_indices, reference_vertices);
+        candidate_fill_terrain_normals(matrix_start[i], matrix_end[i], terrain_indices, terrain_vertices);
+    }
+
+    for (size_t i = 0; i < TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE; ++i) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            max_error = glm_max(max_error, fabsf(reference_vertices[i].normal[axis] - terrain_vertices[i].normal[axis]));
+        }
+    }
+
+    return max_error;
+}
+
+// compare the candidate normals against the reference ones, over the whole terrain and over the parts updated after moves
+static bool check_fill_terrain_normals(void)
+{
+    // moves on a single axis and on both, in both directions
+    const ivec3s moves[] = {
+        {.x = 3, .z = 0}, {.x = 0, .z = 4}, {.x = -5, .z = 0}, {.x = 0, .z = -2},
+        {.x = 7, .z = -3}, {.x = -1, .z = 6}, {.x = -4, .z = -4}, {.x = 2, .z = 5},
+    };
+    const size_t num_moves = sizeof(moves) / sizeof(moves[0]);
+    float max_error = 0;
+    size_t num_strips = 0;
+
+    for (size_t s = 0; s < sizeof(seeds) / sizeof(seeds[0]); s += 2) {
+        reset_terrain(seeds[s]);
+
+        // recompute the normals from scratch
+        for (size_t i = 0; i < TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE; ++i) {
+            glm_vec3_zero(terrain_vertices[i].normal);
+        }
+        const ivec3s matrix_start = { .x = 0, .z = 0 };
+        const ivec3s matrix_end   = { .x = TERRAIN_NUM_VERTICES_SIDE, .z = TERRAIN_NUM_VERTICES_SIDE };
+        max_error = glm_max(max_error, compare_normals(&matrix_start, &matrix_end, 1));
+
+        // update the normals of the strips generated after each move, as update_terrain_normals does
+        for (size_t move = 0; move < num_moves; ++move) {
+            ivec3s strips_start[TERRAIN_NUM_UPDATE_STRIPS], strips_end[TERRAIN_NUM_UPDATE_STRIPS];
+
+            update_terrain_vertices(moves[move], terrain_vertices);
+            get_terrain_update_strips(moves[move], strips_start, strips_end);
+            max_error = glm_max(max_error, compare_normals(strips_start, strips_end, TERRAIN_NUM_UPDATE_STRIPS));
+            num_strips += TERRAIN_NUM_UPDATE_STRIPS;
+        }
+    }
+
+    printf("fill_terrain_normals: max absolute error %g, over the whole terrain and %zu updated strips\n", max_error, num_strips);
+
+    return max_error <= MAX_NORMAL_ERROR;
+}
+
+// compare two triangles given as their indices, for qsort
+static int compare_triangles(const void* a, const void* b)
+{
+    const unsigned int* triangle_a = a;
+    const unsigned int* triangle_b = b;
+
+    for (size_t i = 0; i < NUM_VERTICES_IN_TRIANGLE; ++i) {
+        if (triangle_a[i] != triangle_b[i]) {
+            return (triangle_a[i] < triangle_b[i]) ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+// sort a list of triangles, each one rotated to start from its smallest index so that its winding is kept
+static void sort_triangles(const unsigned int indices[TERRAIN_NUM_DRAW_INDICES], unsigned int sorted[TERRAIN_NUM_DRAW_INDICES])
+{
+    for (size_t i = 0; i < TERRAIN_NUM_DRAW_INDICES; i += NUM_VERTICES_IN_TRIANGLE) {
+        size_t first = 0;
+        for (size_t j = 1; j < NUM_VERTICES_IN_TRIANGLE; ++j) {
+            first = (indices[i + j] < indices[i + first]) ? j : first;
+        }
+        for (size_t j = 0; j < NUM_VERTICES_IN_TRIANGLE; ++j) {
+            sorted[i + j] = indices[i + ((first + j) % NUM_VERTICES_IN_TRIANGLE)];
+        }
+    }
+
+    qsort(sorted, TERRAIN_NUM_DRAW_INDICES / NUM_VERTICES_IN_TRIANGLE, NUM_VERTICES_IN_TRIANGLE * sizeof(sorted[0]), compare_triangles);
+}
+
+// check that the tiled draw order draws the same triangles, with the same winding, as the row order the normals use,
+// and that it needs the expected vertex shader invocations per triangle
+static bool check_draw_indices(void)
+{
+    reset_terrain(seeds[0]);
+    fill_terrain_draw_indices(TERRAIN_ROW_ORDER_TILE_SIZE, row_draw_indices);
+
+    // the row order is the order of the indices used by the normals
+    const bool row_order_matches = memcmp(row_draw_indices, terrain_indices, sizeof(row_draw_indices)) == 0;
+
+    sort_triangles(row_draw_indices, sorted_triangles[0]);
+    sort_triangles(terrain_draw_indices, sorted_triangles[1]);
+    const bool triangles_match = memcmp(sorted_triangles[0], sorted_triangles[1], sizeof(sorted_triangles[0])) == 0;
+
+    // each vertex of a row is transformed for the two rows of squares it belongs to, unless the row fits in the cache
+    // as in a tile, then only the vertices of the first row of the tile are transformed twice
+    const size_t tile_size = TERRAIN_TILE_SIZE;
+    const float expected_row_acmr  = 1;
+    const float expected_tile_acmr = (2 * (tile_size + 1) <= ACMR_CACHE_SIZE) ? (tile_size + 1.0f) / (2 * tile_size) : 1;
+    float max_error = 0;
+
+    for (VertexCachePolicy policy = VERTEX_CACHE_FIFO; policy <= VERTEX_CACHE_LRU; ++policy) {
+        const float row_acmr  = compute_acmr(row_draw_indices, TERRAIN_NUM_DRAW_INDICES, ACMR_CACHE_SIZE, policy);
+        const float tile_acmr = compute_acmr(terrain_draw_indices, TERRAIN_NUM_DRAW_INDICES, ACMR_CACHE_SIZE, policy);
+
+        printf("draw order ACMR:      %s, %.3f for rows and %.3f for tiles of %zu, expected %.3f and %.3f\n",
+               (policy == VERTEX_CACHE_FIFO) ? "FIFO" : "LRU ", row_acmr, tile_acmr, tile_size, expected_row_acmr, expected_tile_acmr);
+        max_error = glm_max(max_error, fabsf(row_acmr - expected_row_acmr));
+        max_error = glm_max(max_error, fabsf(tile_acmr - expected_tile_acmr));
+    }
+
+    printf("draw order triangles: rows %s the normals indices, tiles %s the same triangles\n",
+           row_order_matches ? "match" : "DO NOT match", triangles_match ? "draw" : "DO NOT draw");
+
+    return row_order_matches && triangles_match && max_error <= MAX_ACMR_ERROR;
+}
+
+// compare the whole terrain, after its generation and after moving the player, against the golden hashes
+static bool check_golden_hashes(void)
+{
+    const Vertex* center = &terrain_vertices[(TERRAIN_NUM_VERTICES_SIDE / 2) * (TERRAIN_NUM_VERTICES_SIDE + 1)];
+    bool passed = true;
+    float max_center_offset = 0;
+
+    for (size_t i = 0; i < sizeof(golden_hashes) / sizeof(golden_hashes[0]); ++i) {
+        reset_terrain(golden_hashes[i].seed);
+        const uint64_t init_hash = hash_vertices(terrain_vertices);
+
+        for (size_t move = 0; move < sizeof(player_moves) / sizeof(player_moves[0]); ++move) {
+            for (int repeat = 0; repeat < player_moves[move].repeat; ++repeat) {
+                move_player(player_moves[move].key, &angle_rad_y);
+                const ivec3s num_chunks = update_terrain();
+
+                // the terrain is drawn translated by the player position, so it must stay centered on its opposite
+                if (num_chunks.x != 0 || num_chunks.z != 0) {
+                    max_center_offset = glm_max(max_center_offset, fabsf(center->coords[0] + position.x));
+                    max_center_offset = glm_max(max_center_offset, fabsf(center->coords[2] + position.z));
+                }
+            }
+        }
+        const uint64_t moved_hash = hash_vertices(terrain_vertices);
+
+        const bool matches = init_hash == golden_hashes[i].init_hash && moved_hash == golden_hashes[i].moved_hash;
+        printf("golden seed %4d:      init 0x%016llx, moved 0x%016llx %s\n", golden_hashes[i].seed,
+               (unsigned long long)init_hash, (unsigned long long)moved_hash, matches ? "ok" : "MISMATCH");
+
+        passed = passed && matches;
+    }
+
+    printf("terrain center:       max %g from the player after an update\n", max_center_offset);
+
+    return passed && max_center_offset <= MAX_CENTER_OFFSET;
+}
+
+// intersect a ray with a triangle, using the Moller-Trumbore algorithm
+static bool intersect_triangle(vec3s origin, vec3s direction, Vertex v1, Vertex v2, Vertex v3,
+                               const float min_distance, float* distance)
+{
+    vec3 edge1, edge2, ray_cross_edge2, origin_offset, offset_cross_edge1;
+
+    glm_vec3_sub(v2.coords, v1.coords, edge1);
+    glm_vec3_sub(v3.coords, v1.coords, edge2);
+    glm_vec3_cross(direction.raw, edge2, ray_cross_edge2);
+    const float determinant = glm_vec3_dot(edge1, ray_cross_edge2);
+    if (fabsf(determinant) <= FLT_EPSILON * glm_vec3_norm(direction.raw) * glm_vec3_norm(edge1) * glm_vec3_norm(edge2)) {
+        return false;
+    }
+
+    glm_vec3_sub(origin.raw, v1.coords, origin_offset);
+    const float u = glm_vec3_dot(origin_offset, ray_cross_edge2) / determinant;
+    glm_vec3_cross(origin_offset, edge1, offset_cross_edge1);
+    const float v = glm_vec3_dot(direction.raw, offset_cross_edge1) / determinant;
+    const float t = glm_vec3_dot(edge2, offset_cross_edge1) / determinant;
+    if (u < 0 || u > 1 || v < 0 || u + v > 1 || t < min_distance || t > *distance) {
+        return false;
+    }
+
+    *distance = t;
+    return true;
+}
+
+// find the closest intersection of a ray with the terrain, walking over the triangles of every square
+static bool intersect_terrain(const vec3s origin, const vec3s direction, const float min_distance, const float max_distance,
+                              float* distance)
+{
+    bool hit = false;
+    *distance = max_distance;
+
+    for (size_t j = 0; j < TERRAIN_NUM_VERTICES_SIDE - 1; ++j) {
+        for (size_t i = 0; i < TERRAIN_NUM_VERTICES_SIDE - 1; ++i) {
+            const size_t current_pos = (j * TERRAIN_NUM_VERTICES_SIDE) + i;
+            const Vertex vertex      = terrain_vertices[current_pos];
+            const Vertex right       = terrain_vertices[current_pos + 1];
+            const Vertex below       = terrain_vertices[current_pos + TERRAIN_NUM_VERTICES_SIDE];
+            const Vertex below_right = terrain_vertices[current_pos + TERRAIN_NUM_VERTICES_SIDE + 1];
+
+            hit = intersect_triangle(origin, direction, below, vertex, below_right, min_distance, distance) || hit;
+            hit = intersect_triangle(origin, direction, vertex, right, below_right, min_distance, distance) || hit;
+        }
+    }
+
+    return hit;
+}
+
+// compare the ray and visibility queries of the incremental and rebuilt height pyramids with a brute force walk,
+// while the player turns and moves by fractional amounts like in main.c
+static bool check_height_pyramid(void)
+{
+    size_t num_updates = 0, num_checks = 0, num_brute_force_mismatches = 0, num_rebuild_mismatches = 0;
+    size_t num_short_direction_mismatches = 0;
+
+    reset_terrain(seeds[1]);
+    init_height_pyramid(&height_pyramid, terrain_vertices);
+
+    for (size_t move = 0; move < sizeof(player_moves) / sizeof(player_moves[0]); ++move) {
+        for (int repeat = 0; repeat < player_moves[move].repeat; ++repeat) {
+            move_player(player_moves[move].key, &angle_rad_y);
+            const ivec3s num_chunks = update_terrain();
+            if (num_chunks.x == 0 && num_chunks.z == 0) {
+                continue;
+            }
+
+            // keep the pyramid updated after every move, but only check it every few of them
+            update_height_pyramid(&height_pyramid, num_chunks, terrain_vertices);
+            if (++num_updates % PYRAMID_CHECK_STEP != 0) {
+                continue;
+            }
+            init_height_pyramid(&rebuilt_height_pyramid, terrain_vertices);
+            ++num_checks;
+
+            // rays going down from above the terrain and segments from the air to points near the ground
+            Ray rays[NUM_QUERIES], short_rays[NUM_QUERIES];
+            vec3s from[NUM_QUERIES], to[NUM_QUERIES];
+            for (size_t i = 0; i < NUM_QUERIES; ++i) {
+                const Vertex target = terrain_vertices[rand() % (TERRAIN_NUM_VERTICES_SIDE * TERRAIN_NUM_VERTICES_SIDE)];
+
+                rays[i] = (Ray) {
+                    .origin = { .x = target.coords[0] + random_float(-40, 40), .y = random_float(5, 50),
+                                .z = target.coords[2] + random_float(-40, 40) },
+                    .direction = { .x = random_float(-1, 1), .y = random_float(-0.3, 0.02), .z = random_float(-1, 1) },
+                    .max_distance = 2000
+                };
+                short_rays[i] = (Ray) {
+                    .origin = rays[i].origin,
+                    .direction = { .x = rays[i].direction.x * SHORT_DIRECTION_SCALE, .y = rays[i].direction.y * SHORT_DIRECTION_SCALE,
+                                   .z = rays[i].direction.z * SHORT_DIRECTION_SCALE },
+                    .max_distance = rays[i].max_distance / SHORT_DIRECTION_SCALE
+                };
+                from[i] = rays[i].origin;
+                to[i] = (vec3s) { .x = target.coords[0], .y = target.coords[1] + random_float(0, 3), .z = target.coords[2] };
+            }
+
+            RayHit hits[NUM_QUERIES], rebuilt_hits[NUM_QUERIES], short_hits[NUM_QUERIES];
+            bool visible[NUM_QUERIES], rebuilt_visible[NUM_QUERIES];
+            cast_rays(&height_pyramid, terrain_vertices, rays, NUM_QUERIES, hits);
+            cast_rays(&rebuilt_height_pyramid, terrain_vertices, rays, NUM_QUERIES, rebuilt_hits);
+            cast_rays(&height_pyramid, terrain_vertices, short_rays, NUM_QUERIES, short_hits);
+            check_visibility(&height_pyramid, terrain_vertices, from, to, NUM_QUERIES, visible);
+            check_visibility(&rebuilt_height_pyramid, terrain_vertices, from, to, NUM_QUERIES, rebuilt_visible);
+
+            for (size_t i = 0; i < NUM_QUERIES; ++i) {
+                float distance;
+                const bool hit = intersect_terrain(rays[i].origin, rays[i].direction, 0, rays[i].max_distance, &distance);
+                if (hits[i].hit != hit || (hit && fabsf(hits[i].distance - distance) > MAX_DISTANCE_ERROR)) {
+                    ++num_brute_force_mismatches;
+                }
+                if (hits[i].hit != rebuilt_hits[i].hit || (hits[i].hit && fabsf(hits[i].distance - rebuilt_hits[i].distance) > MAX_DISTANCE_ERROR)) {
+                    ++num_rebuild_mismatches;
+                }
+                if (hits[i].hit != short_hits[i].hit ||
+                    (hits[i].hit && fabsf(hits[i].distance - (short_hits[i].distance * SHORT_DIRECTION_SCALE)) > MAX_DISTANCE_ERROR)) {
+                    ++num_short_direction_mismatches;
+                }
+
+                // segments are blocked by hits away from their ends, like in check_visibility
+                const vec3s direction = { .x = to[i].x - from[i].x, .y = to[i].y - from[i].y, .z = to[i].z - from[i].z };
+                const bool blocked = intersect_terrain(from[i], direction, 1e-4f, 1 - 1e-4f, &distance);
+                if (visible[i] == blocked) {
+                    ++num_brute_force_mismatches;
+                }
+                if (visible[i] != rebuilt_visible[i]) {
+                    ++num_rebuild_mismatches;
+                }
+            }
+        }
+    }
+
+    printf("height pyramid:       %zu rays and %zu segments over %zu of %zu updates, %zu brute force and %zu rebuild mismatches\n",
+           num_checks * NUM_QUERIES, num_checks * NUM_QUERIES, num_checks, num_updates,
+           num_brute_force_mismatches, num_rebuild_mismatches);
+    printf("                      %zu mismatches with directions scaled by %g\n", num_short_direction_mismatches, SHORT_DIRECTION_SCALE);
+
+    return num_checks > 0 && num_brute_force_mismatches == 0 && num_rebuild_mismatches == 0 && num_short_direction_mismatches == 0;
+}
+
+// check that the candidate kernels generate the same terrain as the frozen scalar reference ones
+int main(void)
+{
+    srand(1);
+
+    bool passed = check_fractal_noise();
+    passed = check_generate_vertex() && passed;
+    passed = check_fill_terrain_normals() && passed;
+    passed = check_draw_indices() && passed;
+    passed = check_golden_hashes() && passed;
+    passed = check_height_pyramid() && passed;
+
+    printf("%s\n", passed ? "all checks passed" : "some checks FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}